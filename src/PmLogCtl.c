@@ -37,17 +37,224 @@
 
 bool flag_silence = false;
 
+/*
+ * Facility and level names, as used by PmLogLib, are looked up with
+ * perfect hashes over the name length and a few of its characters.
+ * The hash parameters were chosen offline so that no two names
+ * collide; if a name is added, re-check that it gets a free slot.
+ * Anything not in the tables, e.g. an alias, falls back to PmLogLib.
+ */
+
+#define FACILITY_HASH(s, len) \
+    ((2 * (len) + 4 * (unsigned char) (s)[ 0 ] + \
+      3 * (unsigned char) (s)[ 1 ] + 5 * (unsigned char) (s)[ (len) - 1 ]) & 31)
+
+#define LEVEL_HASH(s, len) \
+    (((len) + 7 * (unsigned char) (s)[ 1 ]) & 15)
+
+/* longest facility or level name handed to PmLogLib */
+#define PRI_NAME_MAX_LEN    15
+
+
 /**
- * @brief ParseFacility
+ * kFacilityHashTable
  *
- * "user" => LOG_USER, etc.
+ * Facility names by FACILITY_HASH slot.
+ */
+static const IntLabel kFacilityHashTable[ 32 ] =
+{
+	[  0 ] = { "lpr",      LOG_LPR },
+	[  1 ] = { "authpriv", LOG_AUTHPRIV },
+	[  3 ] = { "local2",   LOG_LOCAL2 },
+	[  5 ] = { "daemon",   LOG_DAEMON },
+	[  6 ] = { "syslog",   LOG_SYSLOG },
+	[  8 ] = { "local3",   LOG_LOCAL3 },
+	[  9 ] = { "kern",     LOG_KERN },
+	[ 10 ] = { "ftp",      LOG_FTP },
+	[ 11 ] = { "uucp",     LOG_UUCP },
+	[ 13 ] = { "local4",   LOG_LOCAL4 },
+	[ 14 ] = { "news",     LOG_NEWS },
+	[ 15 ] = { "user",     LOG_USER },
+	[ 16 ] = { "cron",     LOG_CRON },
+	[ 18 ] = { "local5",   LOG_LOCAL5 },
+	[ 19 ] = { "auth",     LOG_AUTH },
+	[ 23 ] = { "local6",   LOG_LOCAL6 },
+	[ 25 ] = { "local0",   LOG_LOCAL0 },
+	[ 27 ] = { "mail",     LOG_MAIL },
+	[ 28 ] = { "local7",   LOG_LOCAL7 },
+	[ 30 ] = { "local1",   LOG_LOCAL1 }
+};
+
+
+/**
+ * kLevelHashTable
+ *
+ * Level names by LEVEL_HASH slot.
+ */
+static const IntLabel kLevelHashTable[ 16 ] =
+{
+	[  0 ] = { "emerg",    kPmLogLevel_Emergency },
+	[  1 ] = { "err",      kPmLogLevel_Error },
+	[  2 ] = { "crit",     kPmLogLevel_Critical },
+	[  6 ] = { "info",     kPmLogLevel_Info },
+	[  8 ] = { "debug",    kPmLogLevel_Debug },
+	[  9 ] = { "alert",    kPmLogLevel_Alert },
+	[ 13 ] = { "none",     kPmLogLevel_None },
+	[ 14 ] = { "warning",  kPmLogLevel_Warning },
+	[ 15 ] = { "notice",   kPmLogLevel_Notice }
+};
+
+
+/**
+ * kFacilityNames
+ *
+ * Facility names indexed by facility number, i.e. LOG_xxx >> 3.
+ */
+static const char *kFacilityNames[ LOG_NFACILITIES ] =
+{
+	/*  0 */ "kern",
+	/*  1 */ "user",
+	/*  2 */ "mail",
+	/*  3 */ "daemon",
+	/*  4 */ "auth",
+	/*  5 */ "syslog",
+	/*  6 */ "lpr",
+	/*  7 */ "news",
+	/*  8 */ "uucp",
+	/*  9 */ "cron",
+	/* 10 */ "authpriv",
+	/* 11 */ "ftp",
+	/* 12 */ NULL,
+	/* 13 */ NULL,
+	/* 14 */ NULL,
+	/* 15 */ NULL,
+	/* 16 */ "local0",
+	/* 17 */ "local1",
+	/* 18 */ "local2",
+	/* 19 */ "local3",
+	/* 20 */ "local4",
+	/* 21 */ "local5",
+	/* 22 */ "local6",
+	/* 23 */ "local7"
+};
+
+
+/**
+ * kLevelNames
+ *
+ * Level names indexed by level + 1, as kPmLogLevel_None is -1.
+ */
+static const char *kLevelNames[ 1 + 8 ] =
+{
+	/* -1 */ "none",
+	/*  0 */ "emerg",
+	/*  1 */ "alert",
+	/*  2 */ "crit",
+	/*  3 */ "err",
+	/*  4 */ "warning",
+	/*  5 */ "notice",
+	/*  6 */ "info",
+	/*  7 */ "debug"
+};
+
+
+#define PRI_STRS(fac) \
+    fac ".emerg", fac ".alert", fac ".crit", fac ".err", \
+    fac ".warning", fac ".notice", fac ".info", fac ".debug"
+
+#define PRI_STRS_NONE \
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL
+
+
+/**
+ * kPriorityStrs
+ *
+ * "<facility>.<level>" strings indexed by priority value, i.e.
+ * facility | level.
+ */
+static const char *kPriorityStrs[ LOG_NFACILITIES * 8 ] =
+{
+	PRI_STRS("kern"),
+	PRI_STRS("user"),
+	PRI_STRS("mail"),
+	PRI_STRS("daemon"),
+	PRI_STRS("auth"),
+	PRI_STRS("syslog"),
+	PRI_STRS("lpr"),
+	PRI_STRS("news"),
+	PRI_STRS("uucp"),
+	PRI_STRS("cron"),
+	PRI_STRS("authpriv"),
+	PRI_STRS("ftp"),
+	PRI_STRS_NONE,
+	PRI_STRS_NONE,
+	PRI_STRS_NONE,
+	PRI_STRS_NONE,
+	PRI_STRS("local0"),
+	PRI_STRS("local1"),
+	PRI_STRS("local2"),
+	PRI_STRS("local3"),
+	PRI_STRS("local4"),
+	PRI_STRS("local5"),
+	PRI_STRS("local6"),
+	PRI_STRS("local7")
+};
+
+
+/**
+ * @brief PrvLookupHashedLabel
+ *
+ * Check the perfect hash table slot for the given name.
+ * @return the table entry if it matches, else NULL.
+ */
+static const IntLabel *PrvLookupHashedLabel(const IntLabel *labelP,
+        const char *s, size_t len)
+{
+	if ((labelP->s != NULL) &&
+	        (strncmp(labelP->s, s, len) == 0) && (labelP->s[ len ] == 0))
+	{
+		return labelP;
+	}
+
+	return NULL;
+}
+
+
+/**
+ * @brief ParseFacilityLen
+ *
+ * As ParseFacility, for the first 'len' characters of 's'.
  * @return true if parsed OK, else false.
  */
-bool ParseFacility(const char *facilityStr, int *facilityP)
+bool ParseFacilityLen(const char *s, size_t len, int *facilityP)
 {
-	const int *nP;
+	const IntLabel *labelP;
+	const int      *nP;
+	char            str[ PRI_NAME_MAX_LEN + 1 ];
+
+	*facilityP = -1;
+
+	if (len >= 2)
+	{
+		labelP = PrvLookupHashedLabel(&kFacilityHashTable[ FACILITY_HASH(s, len) ],
+		                              s, len);
 
-	nP = PmLogStringToFacility(facilityStr);
+		if (labelP != NULL)
+		{
+			*facilityP = labelP->n;
+			return true;
+		}
+	}
+
+	if ((len == 0) || (len > PRI_NAME_MAX_LEN))
+	{
+		return false;
+	}
+
+	memcpy(str, s, len);
+	str[ len ] = 0;
+
+	nP = PmLogStringToFacility(str);
 
 	if (nP != NULL)
 	{
@@ -55,22 +262,45 @@ bool ParseFacility(const char *facilityStr, int *facilityP)
 		return true;
 	}
 
-	*facilityP = -1;
 	return false;
 }
 
 
 /**
- * @brief ParseLevel
+ * @brief ParseLevelLen
  *
- * "err" => LOG_ERR, etc.
+ * As ParseLevel, for the first 'len' characters of 's'.
  * @return true if parsed OK, else false.
  */
-bool ParseLevel(const char *levelStr, int *levelP)
+bool ParseLevelLen(const char *s, size_t len, int *levelP)
 {
-	const int *nP;
+	const IntLabel *labelP;
+	const int      *nP;
+	char            str[ PRI_NAME_MAX_LEN + 1 ];
+
+	*levelP = -1;
+
+	if (len >= 2)
+	{
+		labelP = PrvLookupHashedLabel(&kLevelHashTable[ LEVEL_HASH(s, len) ],
+		                              s, len);
 
-	nP = PmLogStringToLevel(levelStr);
+		if (labelP != NULL)
+		{
+			*levelP = labelP->n;
+			return true;
+		}
+	}
+
+	if ((len == 0) || (len > PRI_NAME_MAX_LEN))
+	{
+		return false;
+	}
+
+	memcpy(str, s, len);
+	str[ len ] = 0;
+
+	nP = PmLogStringToLevel(str);
 
 	if (nP != NULL)
 	{
@@ -78,11 +308,61 @@ bool ParseLevel(const char *levelStr, int *levelP)
 		return true;
 	}
 
-	*levelP = -1;
 	return false;
 }
 
 
+/**
+ * @brief PrvStringToLevel
+ *
+ * As PmLogStringToLevel, but looking in the level table first.
+ */
+static const int *PrvStringToLevel(const char *levelStr)
+{
+	const IntLabel *labelP;
+	size_t          len;
+
+	len = strlen(levelStr);
+
+	if (len >= 2)
+	{
+		labelP = PrvLookupHashedLabel(&kLevelHashTable[ LEVEL_HASH(levelStr, len) ],
+		                              levelStr, len);
+
+		if (labelP != NULL)
+		{
+			return &labelP->n;
+		}
+	}
+
+	return PmLogStringToLevel(levelStr);
+}
+
+
+/**
+ * @brief ParseFacility
+ *
+ * "user" => LOG_USER, etc.
+ * @return true if parsed OK, else false.
+ */
+bool ParseFacility(const char *facilityStr, int *facilityP)
+{
+	return ParseFacilityLen(facilityStr, strlen(facilityStr), facilityP);
+}
+
+
+/**
+ * @brief ParseLevel
+ *
+ * "err" => LOG_ERR, etc.
+ * @return true if parsed OK, else false.
+ */
+bool ParseLevel(const char *levelStr, int *levelP)
+{
+	return ParseLevelLen(levelStr, strlen(levelStr), levelP);
+}
+
+
 /**
  * @brief GetFacilityStr
  *
@@ -90,10 +370,14 @@ bool ParseLevel(const char *levelStr, int *levelP)
  */
 const char *GetFacilityStr(int facility)
 {
-	const char *facilityStr;
+	if (((facility & ~LOG_FACMASK) == 0) &&
+	        (LOG_FAC(facility) < LOG_NFACILITIES) &&
+	        (kFacilityNames[ LOG_FAC(facility) ] != NULL))
+	{
+		return kFacilityNames[ LOG_FAC(facility) ];
+	}
 
-	facilityStr = PmLogFacilityToString(facility);
-	return facilityStr;
+	return PmLogFacilityToString(facility);
 }
 
 
@@ -104,10 +388,28 @@ const char *GetFacilityStr(int facility)
  */
 const char *GetLevelStr(int level)
 {
-	const char *levelStr;
+	if ((level >= kPmLogLevel_None) && (level <= kPmLogLevel_Debug))
+	{
+		return kLevelNames[ level + 1 ];
+	}
+
+	return PmLogLevelToString(level);
+}
+
+
+/**
+ * @brief GetPriorityStr
+ *
+ * LOG_USER | LOG_ERR => "user.err", etc.  NULL if not recognized.
+ */
+const char *GetPriorityStr(int pri)
+{
+	if ((pri >= 0) && (pri < LOG_NFACILITIES * 8))
+	{
+		return kPriorityStrs[ pri ];
+	}
 
-	levelStr = PmLogLevelToString(level);
-	return levelStr;
+	return NULL;
 }
 
 
@@ -326,7 +628,7 @@ static void ShowContext(const ContextInfo_t *contextInfoP)
 {
 	const char *levelStr;
 
-	levelStr = PmLogLevelToString(contextInfoP->context->enabledLevel);
+	levelStr = GetLevelStr(contextInfoP->context->enabledLevel);
 
 	if (levelStr == NULL)
 	{
@@ -463,7 +765,7 @@ static Result DoCmdSet(int argc, char *argv[])
 		}
 		else if (levelIntP == NULL)
 		{
-			levelIntP = PmLogStringToLevel(arg);
+			levelIntP = PrvStringToLevel(arg);
 
 			if (levelIntP == NULL)
 			{
@@ -615,7 +917,7 @@ static Result DoCmdLog(int argc, char *argv[])
 		}
 		else if (levelIntP == NULL)
 		{
-			levelIntP = PmLogStringToLevel(arg);
+			levelIntP = PrvStringToLevel(arg);
 
 			if ((levelIntP == NULL) ||
 			        (*levelIntP == -1))
@@ -724,7 +1026,7 @@ static Result DoCmdLogKV(int argc, char *argv[])
 		}
 		else if (levelIntP == NULL)
 		{
-			levelIntP = PmLogStringToLevel(arg);
+			levelIntP = PrvStringToLevel(arg);
 
 			if ((levelIntP == NULL) ||
 			        (*levelIntP == -1))
@@ -960,7 +1262,7 @@ static Result DoCmdKLog(int argc, char *argv[])
 				}
 
 				arg = argv[ i ];
-				levelIntP = PmLogStringToLevel(arg);
+				levelIntP = PrvStringToLevel(arg);
 
 				if (levelIntP == NULL)
 				{
@@ -1128,7 +1430,7 @@ static Result DoCmdDef(int argc, char *argv[])
 		}
 		else if (levelIntP == NULL)
 		{
-			levelIntP = PmLogStringToLevel(arg);
+			levelIntP = PrvStringToLevel(arg);
 
 			if (levelIntP == NULL)
 			{
@@ -1201,6 +1503,67 @@ static void ShowUsage(void)
 	InfoPrint("  reconf                       # re-load lib options from conf\n");
 	InfoPrint("  set <context> <level>        # set logging context level\n");
 	InfoPrint("  show [<context>]             # show logging context(s)\n");
+	InfoPrint("  view [<options>] [<file>...] # view the merged log files, by default\n");
+	InfoPrint("                               # those in PmLog.conf\n");
+	InfoPrint("    --templates                # summarize messages by template\n");
+	InfoPrint("    --collapse-repeats         # output identical consecutive messages once\n");
+	InfoPrint("    --dedup-window <time>      # drop copies from other log files within\n");
+	InfoPrint("                               # <time>, e.g. 500us, 20ms, 1s\n");
+	InfoPrint("    --bad-lines stop|skip|pass # on a line that fails to parse, end its\n");
+	InfoPrint("                               # log file, or drop it, or output it as is\n");
+	InfoPrint("    --reorder-window <time>    # restore the order of messages up to <time>\n");
+	InfoPrint("                               # apart in each log file\n");
+	InfoPrint("    --reorder-count <count>    # read ahead up to <count> messages per log\n");
+	InfoPrint("                               # file to restore their order, default 1024\n");
+	InfoPrint("                               # with --reorder-window\n");
+	InfoPrint("    --sort                     # sort each log file fully by time first\n");
+	InfoPrint("    --mem-limit <size>         # memory for --sort before using temporary\n");
+	InfoPrint("                               # files, e.g. 512M, default 64M\n");
+	InfoPrint("    -o <path>                  # write to <path>, compressed if it ends\n");
+	InfoPrint("                               # in .gz or .zst\n");
+	InfoPrint("    --export columnar          # write binary column blocks, which can be\n");
+	InfoPrint("                               # viewed again as <file>\n");
+	InfoPrint("    --export trace             # write Chrome trace events, a track per\n");
+	InfoPrint("                               # program, with --spans as durations\n");
+	InfoPrint("    --format text|json|csv     # output text lines, JSON Lines or CSV\n");
+	InfoPrint("    --format <format>          # output text lines laid out by <format>:\n");
+	InfoPrint("                               # %%t UTC time, %%T local time, %%3t with\n");
+	InfoPrint("                               # 3 fraction digits, %%h host, %%P priority,\n");
+	InfoPrint("                               # %%f facility, %%l level, %%p program,\n");
+	InfoPrint("                               # %%i pid, %%c context, %%m message, %%%% '%%',\n");
+	InfoPrint("                               # %%(...%%) left out if its fields are empty\n");
+	InfoPrint("    --fields <field>,...       # output only ts, host, pri, prog, pid,\n");
+	InfoPrint("                               # ctx and/or msg, e.g. ctx,msg\n");
+	InfoPrint("    --sample <mode>:<n>        # output a sample of the messages: every:<n>\n");
+	InfoPrint("                               # the first of every <n>, per-second:<n>\n");
+	InfoPrint("                               # <n> at random each second, reservoir:<n>\n");
+	InfoPrint("                               # <n> at random from all\n");
+	InfoPrint("    --context <name>           # only messages from this context\n");
+	InfoPrint("    --program <name>           # only messages from this program\n");
+	InfoPrint("    --level <level>            # only messages at least this severe\n");
+	InfoPrint("    --since <time>             # only messages up to <time> ago, e.g. 1h\n");
+	InfoPrint("    --msgid <msgID>            # only PmLogString messages with <msgID>\n");
+	InfoPrint("    --kv <key>=<value>         # only messages with the key/value pair\n");
+	InfoPrint("    --count                    # output only the number of messages\n");
+	InfoPrint("    --exists                   # output nothing, succeed if there is a\n");
+	InfoPrint("                               # message, stopping at the first\n");
+	InfoPrint("    --agg <key> [by msgid|context]\n");
+	InfoPrint("                               # output the count, min, max, mean and\n");
+	InfoPrint("                               # percentiles of the key's values by group\n");
+	InfoPrint("    --spans <begin>,<end> [by pid|<key>]\n");
+	InfoPrint("                               # output the spans between msgIDs, e.g.\n");
+	InfoPrint("                               # *_START,*_DONE, and their durations\n");
+	InfoPrint("    --span-timeout <time>      # drop spans not ended in <time>, def. 10m\n");
+	InfoPrint("    --compare <start>,<end> <start>,<end>\n");
+	InfoPrint("                               # output the message rates of two time\n");
+	InfoPrint("                               # windows by context, program and template\n");
+	InfoPrint("    --rollup                   # update <file>.rollup next to each log\n");
+	InfoPrint("                               # with new per-minute message counts\n");
+	InfoPrint("    --timeline [by context|level|program]\n");
+	InfoPrint("                               # output the per-minute counts from the\n");
+	InfoPrint("                               # rollup files instead of the logs\n");
+	InfoPrint("    -A|-B|-C <n>               # also output <n> messages after, before or\n");
+	InfoPrint("                               # around each one that matches the filters\n");
 	InfoPrint("\n");
 
 	InfoPrint("Contexts:\n");
@@ -1212,7 +1575,7 @@ static void ShowUsage(void)
 
 	for (level = -1 /* kPmLogLevel_None */; level <= 7; level++)
 	{
-		InfoPrint("  %-10s  # %d\n", PmLogLevelToString(level), level);
+		InfoPrint("  %-10s  # %d\n", GetLevelStr(level), level);
 	}
 }
 
@@ -29,6 +29,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 
 /* Debugging/Error reporting utilities */
@@ -120,6 +121,23 @@ const char *PrvGetIntLabel(const IntLabel *labels, int n);
 const int *PrvLabelToInt(const IntLabel *labels, const char *s);
 
 
+/**
+ * HASH64_INIT
+ *
+ * Initial value to start a PrvHash64 sequence.
+ */
+#define HASH64_INIT 14695981039346656037ULL
+
+
+/**
+ * @brief PrvHash64
+ *
+ * Continue a 64-bit FNV-1a hash over the given bytes.  Multiple
+ * fields can be hashed by passing the previous result back in.
+ */
+uint64_t PrvHash64(uint64_t hash, const void *data, size_t len);
+
+
 typedef enum
 {
     RESULT_OK,
@@ -139,6 +157,15 @@ Result;
 bool ParseFacility(const char *s, int *facilityP);
 
 
+/**
+ * @brief ParseFacilityLen
+ *
+ * As ParseFacility, for the first 'len' characters of 's'.
+ * @return true if parsed OK, else false.
+ */
+bool ParseFacilityLen(const char *s, size_t len, int *facilityP);
+
+
 /**
  * @brief ParseLevel
  *
@@ -148,6 +175,15 @@ bool ParseFacility(const char *s, int *facilityP);
 bool ParseLevel(const char *s, int *levelP);
 
 
+/**
+ * @brief ParseLevelLen
+ *
+ * As ParseLevel, for the first 'len' characters of 's'.
+ * @return true if parsed OK, else false.
+ */
+bool ParseLevelLen(const char *s, size_t len, int *levelP);
+
+
 /**
  * @brief GetFacilityStr
  *
@@ -164,6 +200,59 @@ const char *GetFacilityStr(int fac);
 const char *GetLevelStr(int level);
 
 
+/**
+ * @brief GetPriorityStr
+ *
+ * LOG_USER | LOG_ERR => "user.err", etc.  NULL if not recognized.
+ */
+const char *GetPriorityStr(int pri);
+
+
+typedef enum
+{
+    COMPRESSION_NONE,
+    COMPRESSION_GZIP,
+    COMPRESSION_ZSTD
+}
+Compression_t;
+
+
+/**
+ * @brief GetCompressionSuffix
+ *
+ * COMPRESSION_GZIP => ".gz", etc.  "" for COMPRESSION_NONE.
+ */
+const char *GetCompressionSuffix(Compression_t compression);
+
+
+/**
+ * @brief GetPathCompression
+ *
+ * "messages.0.gz" => COMPRESSION_GZIP, etc.
+ */
+Compression_t GetPathCompression(const char *path);
+
+
+/**
+ * @brief OpenDecompressingFile
+ *
+ * Open the file for reading through the given decompression.
+ * @return the stream, or NULL with errno set on error.
+ */
+FILE *OpenDecompressingFile(const char *path, Compression_t compression);
+
+
+/**
+ * @brief OpenCompressingFile
+ *
+ * Create or truncate the file for writing through the given
+ * compression, which is done on a separate thread.  The stream must
+ * be closed with fclose to complete the file.
+ * @return the stream, or NULL with errno set on error.
+ */
+FILE *OpenCompressingFile(const char *path, Compression_t compression);
+
+
 /**
  * @brief PmLogView.c
  */
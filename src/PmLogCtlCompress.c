@@ -0,0 +1,845 @@
+// Copyright (c) 2007-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ ***********************************************************************
+ * @file PmLogCtlCompress.c
+ *
+ * @brief This file contains the streaming (de)compression of files.
+ *
+ * The compressed streams are wrapped as stdio streams with
+ * fopencookie, so they can be read with getline or written with
+ * fprintf like any other file.  Output is compressed in a thread of
+ * its own, so formatting and compression overlap.
+ * gzip support needs zlib (HAVE_ZLIB), zstd support needs libzstd
+ * (HAVE_ZSTD).
+ *
+ ***********************************************************************
+ */
+
+
+#define _GNU_SOURCE
+
+#include "PmLogCtl.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+#include <sys/types.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+
+/* size of the blocks handed to the compression thread */
+#define COMPRESS_BLOCK_SIZE     (256 * 1024)
+
+/* blocks queued for compression before the writer has to wait */
+#define COMPRESS_NUM_BLOCKS     4
+
+
+/**
+ * kCompressionSuffixes
+ *
+ * File name suffix by compression, see GetPathCompression.
+ */
+static const IntLabel kCompressionSuffixes[] =
+{
+	{ ".gz",    COMPRESSION_GZIP    },
+	{ ".zst",   COMPRESSION_ZSTD    },
+	{ NULL,     COMPRESSION_NONE    }
+};
+
+
+/**
+ * @brief GetCompressionSuffix
+ *
+ * COMPRESSION_GZIP => ".gz", etc.  "" for COMPRESSION_NONE.
+ */
+const char *GetCompressionSuffix(Compression_t compression)
+{
+	const char *suffix;
+
+	suffix = PrvGetIntLabel(kCompressionSuffixes, compression);
+
+	return (suffix != NULL) ? suffix : "";
+}
+
+
+/**
+ * @brief GetPathCompression
+ *
+ * "messages.0.gz" => COMPRESSION_GZIP, etc.
+ */
+Compression_t GetPathCompression(const char *path)
+{
+	const IntLabel *p;
+	size_t          pathLen;
+	size_t          suffixLen;
+
+	pathLen = strlen(path);
+
+	for (p = kCompressionSuffixes; p->s != NULL; p++)
+	{
+		suffixLen = strlen(p->s);
+
+		if ((pathLen > suffixLen) &&
+		        (strcmp(path + pathLen - suffixLen, p->s) == 0))
+		{
+			return (Compression_t) p->n;
+		}
+	}
+
+	return COMPRESSION_NONE;
+}
+
+
+#ifdef HAVE_ZLIB
+
+/**
+ * @brief PrvGzipRead
+ */
+static ssize_t PrvGzipRead(void *cookie, char *buff, size_t size)
+{
+	int n;
+	int err;
+
+	n = gzread((gzFile) cookie, buff, (unsigned int) MIN(size, INT_MAX));
+
+	if (n < 0)
+	{
+		(void) gzerror((gzFile) cookie, &err);
+		errno = (err == Z_ERRNO) ? errno : EIO;
+		return -1;
+	}
+
+	return n;
+}
+
+
+/**
+ * @brief PrvGzipClose
+ */
+static int PrvGzipClose(void *cookie)
+{
+	return (gzclose_r((gzFile) cookie) == Z_OK) ? 0 : EOF;
+}
+
+
+/**
+ * @brief PrvOpenGzipFile
+ */
+static FILE *PrvOpenGzipFile(const char *path)
+{
+	static const cookie_io_functions_t kGzipFunctions =
+	{
+		.read   = PrvGzipRead,
+		.close  = PrvGzipClose
+	};
+
+	gzFile  gz;
+	FILE   *f;
+
+	gz = gzopen(path, "rb");
+
+	if (gz == NULL)
+	{
+		/* errno is set, unless out of memory */
+		return NULL;
+	}
+
+	(void) gzbuffer(gz, 128 * 1024);
+
+	f = fopencookie(gz, "r", kGzipFunctions);
+
+	if (f == NULL)
+	{
+		(void) gzclose_r(gz);
+	}
+
+	return f;
+}
+
+#endif /* HAVE_ZLIB */
+
+
+#ifdef HAVE_ZSTD
+
+typedef struct
+{
+	FILE           *file;
+	ZSTD_DStream   *dstream;
+	ZSTD_inBuffer   in;
+	size_t          inBuffSize;
+	char           *inBuff;
+}
+ZstdReader_t;
+
+
+/**
+ * @brief PrvZstdRead
+ *
+ * Decompress into 'buff' until something is output.  A truncated
+ * stream, as left by a power loss, just ends where the data does.
+ */
+static ssize_t PrvZstdRead(void *cookie, char *buff, size_t size)
+{
+	ZstdReader_t   *readerP = (ZstdReader_t *) cookie;
+	ZSTD_outBuffer  out;
+	size_t          result;
+
+	out.dst = buff;
+	out.size = size;
+	out.pos = 0;
+
+	while (out.pos == 0)
+	{
+		if (readerP->in.pos >= readerP->in.size)
+		{
+			readerP->in.size = fread(readerP->inBuff, 1, readerP->inBuffSize,
+			                         readerP->file);
+			readerP->in.pos = 0;
+
+			if (readerP->in.size == 0)
+			{
+				return ferror(readerP->file) ? -1 : 0;
+			}
+		}
+
+		result = ZSTD_decompressStream(readerP->dstream, &out, &readerP->in);
+
+		if (ZSTD_isError(result))
+		{
+			errno = EIO;
+			return -1;
+		}
+	}
+
+	return out.pos;
+}
+
+
+/**
+ * @brief PrvZstdClose
+ */
+static int PrvZstdClose(void *cookie)
+{
+	ZstdReader_t   *readerP = (ZstdReader_t *) cookie;
+	int             result;
+
+	result = fclose(readerP->file);
+	(void) ZSTD_freeDStream(readerP->dstream);
+	free(readerP->inBuff);
+	free(readerP);
+
+	return result;
+}
+
+
+/**
+ * @brief PrvOpenZstdFile
+ */
+static FILE *PrvOpenZstdFile(const char *path)
+{
+	static const cookie_io_functions_t kZstdFunctions =
+	{
+		.read   = PrvZstdRead,
+		.close  = PrvZstdClose
+	};
+
+	ZstdReader_t   *readerP;
+	FILE           *f;
+
+	readerP = (ZstdReader_t *) calloc(1, sizeof(*readerP));
+
+	if (readerP == NULL)
+	{
+		return NULL;
+	}
+
+	readerP->file = fopen(path, "r");
+
+	if (readerP->file == NULL)
+	{
+		free(readerP);
+		return NULL;
+	}
+
+	readerP->inBuffSize = ZSTD_DStreamInSize();
+	readerP->inBuff = (char *) malloc(readerP->inBuffSize);
+	readerP->dstream = ZSTD_createDStream();
+
+	if ((readerP->inBuff == NULL) || (readerP->dstream == NULL) ||
+	        ZSTD_isError(ZSTD_initDStream(readerP->dstream)))
+	{
+		(void) PrvZstdClose(readerP);
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	readerP->in.src = readerP->inBuff;
+
+	f = fopencookie(readerP, "r", kZstdFunctions);
+
+	if (f == NULL)
+	{
+		(void) PrvZstdClose(readerP);
+	}
+
+	return f;
+}
+
+#endif /* HAVE_ZSTD */
+
+
+/**
+ * @brief OpenDecompressingFile
+ *
+ * Open the file for reading through the given decompression.
+ * @return the stream, or NULL with errno set on error.
+ */
+FILE *OpenDecompressingFile(const char *path, Compression_t compression)
+{
+	switch (compression)
+	{
+		case COMPRESSION_NONE:
+			return fopen(path, "r");
+
+#ifdef HAVE_ZLIB
+
+		case COMPRESSION_GZIP:
+			return PrvOpenGzipFile(path);
+#endif
+
+#ifdef HAVE_ZSTD
+
+		case COMPRESSION_ZSTD:
+			return PrvOpenZstdFile(path);
+#endif
+
+		default:
+			errno = ENOTSUP;
+			return NULL;
+	}
+}
+
+
+#if defined(HAVE_ZLIB) || defined(HAVE_ZSTD)
+
+typedef struct
+{
+	Compression_t   compression;
+	FILE           *file;
+	char           *outBuff;
+	size_t          outBuffSize;
+#ifdef HAVE_ZLIB
+	z_stream        zstream;
+#endif
+#ifdef HAVE_ZSTD
+	ZSTD_CCtx      *cctx;
+#endif
+
+	/*
+	 * the blocks form a ring: 'numQueued' from 'head' are waiting for
+	 * or in compression, and 'fill', the one after them, is being
+	 * filled by the writer
+	 */
+	char           *blocks[ COMPRESS_NUM_BLOCKS ];
+	size_t          blockLens[ COMPRESS_NUM_BLOCKS ];
+	int             head;
+	int             numQueued;
+	int             fill;           /* used by the writer only */
+	int             fillErr;        /* last seen 'err', by the writer only */
+	bool            closing;
+	int             err;            /* of compressing or writing, or 0 */
+
+	pthread_mutex_t mutex;
+	pthread_cond_t  cond;
+	pthread_t       thread;
+}
+CompressWriter_t;
+
+
+/**
+ * @brief PrvWriteCompressed
+ *
+ * Write out what the compressor output to the buffer.
+ * @return true if successful else false, with writerP->err set.
+ */
+static bool PrvWriteCompressed(CompressWriter_t *writerP, size_t len)
+{
+	if (fwrite(writerP->outBuff, 1, len, writerP->file) != len)
+	{
+		writerP->err = errno;
+		return false;
+	}
+
+	return true;
+}
+
+
+/**
+ * @brief PrvCompressBlock
+ *
+ * Compress the block and write the output, or with 'finish' end the
+ * stream.  Called on the compression thread only.
+ * @return true if successful else false, with writerP->err set.
+ */
+static bool PrvCompressBlock(CompressWriter_t *writerP, const char *block,
+                             size_t len, bool finish)
+{
+	switch (writerP->compression)
+	{
+#ifdef HAVE_ZLIB
+
+		case COMPRESSION_GZIP:
+		{
+			z_stream   *zsP = &writerP->zstream;
+			int         result;
+
+			zsP->next_in = (Bytef *) block;
+			zsP->avail_in = (uInt) len;
+
+			do
+			{
+				zsP->next_out = (Bytef *) writerP->outBuff;
+				zsP->avail_out = (uInt) writerP->outBuffSize;
+
+				result = deflate(zsP, finish ? Z_FINISH : Z_NO_FLUSH);
+
+				if ((result == Z_STREAM_ERROR) ||
+				        !PrvWriteCompressed(writerP,
+				                            writerP->outBuffSize - zsP->avail_out))
+				{
+					writerP->err = (writerP->err != 0) ? writerP->err : EIO;
+					return false;
+				}
+			}
+			while ((zsP->avail_in > 0) ||
+			        (finish && (result != Z_STREAM_END)));
+
+			return true;
+		}
+#endif
+
+#ifdef HAVE_ZSTD
+
+		case COMPRESSION_ZSTD:
+		{
+			ZSTD_inBuffer   in;
+			ZSTD_outBuffer  out;
+			size_t          remaining;
+
+			in.src = block;
+			in.size = len;
+			in.pos = 0;
+
+			do
+			{
+				out.dst = writerP->outBuff;
+				out.size = writerP->outBuffSize;
+				out.pos = 0;
+
+				remaining = ZSTD_compressStream2(writerP->cctx, &out, &in,
+				                                 finish ? ZSTD_e_end :
+				                                 ZSTD_e_continue);
+
+				if (ZSTD_isError(remaining))
+				{
+					writerP->err = EIO;
+					return false;
+				}
+
+				if (!PrvWriteCompressed(writerP, out.pos))
+				{
+					return false;
+				}
+			}
+			while ((in.pos < in.size) || (finish && (remaining != 0)));
+
+			return true;
+		}
+#endif
+
+		default:
+			writerP->err = ENOTSUP;
+			return false;
+	}
+}
+
+
+/**
+ * @brief PrvCompressThread
+ *
+ * Compress the queued blocks in order until the writer is closed.
+ */
+static void *PrvCompressThread(void *arg)
+{
+	CompressWriter_t   *writerP = (CompressWriter_t *) arg;
+	int                 i;
+	bool                ok;
+
+	ok = true;
+
+	(void) pthread_mutex_lock(&writerP->mutex);
+
+	for (;;)
+	{
+		while ((writerP->numQueued == 0) && !writerP->closing)
+		{
+			(void) pthread_cond_wait(&writerP->cond, &writerP->mutex);
+		}
+
+		if (writerP->numQueued == 0)
+		{
+			break;
+		}
+
+		i = writerP->head;
+
+		(void) pthread_mutex_unlock(&writerP->mutex);
+
+		/* after an error the rest is dropped, but still dequeued */
+		if (ok)
+		{
+			ok = PrvCompressBlock(writerP, writerP->blocks[ i ],
+			                      writerP->blockLens[ i ], false);
+		}
+
+		(void) pthread_mutex_lock(&writerP->mutex);
+
+		writerP->head = (writerP->head + 1) % COMPRESS_NUM_BLOCKS;
+		writerP->numQueued--;
+		(void) pthread_cond_broadcast(&writerP->cond);
+	}
+
+	(void) pthread_mutex_unlock(&writerP->mutex);
+
+	if (ok)
+	{
+		(void) PrvCompressBlock(writerP, NULL, 0, true);
+	}
+
+	return NULL;
+}
+
+
+/**
+ * @brief PrvQueueBlock
+ *
+ * Hand the block being filled to the compression thread, waiting if
+ * all the blocks are queued already, and start filling the next.
+ */
+static void PrvQueueBlock(CompressWriter_t *writerP)
+{
+	(void) pthread_mutex_lock(&writerP->mutex);
+
+	writerP->numQueued++;
+	(void) pthread_cond_broadcast(&writerP->cond);
+
+	while (writerP->numQueued >= COMPRESS_NUM_BLOCKS)
+	{
+		(void) pthread_cond_wait(&writerP->cond, &writerP->mutex);
+	}
+
+	writerP->fillErr = writerP->err;
+
+	(void) pthread_mutex_unlock(&writerP->mutex);
+
+	writerP->fill = (writerP->fill + 1) % COMPRESS_NUM_BLOCKS;
+	writerP->blockLens[ writerP->fill ] = 0;
+}
+
+
+/**
+ * @brief PrvCompressWrite
+ */
+static ssize_t PrvCompressWrite(void *cookie, const char *buff, size_t size)
+{
+	CompressWriter_t   *writerP = (CompressWriter_t *) cookie;
+	size_t              done;
+	size_t              n;
+	int                 i;
+
+	/* an error is seen as blocks are queued, so it may come late */
+	if (writerP->fillErr != 0)
+	{
+		errno = writerP->fillErr;
+		return -1;
+	}
+
+	for (done = 0; done < size; done += n)
+	{
+		i = writerP->fill;
+
+		n = MIN(size - done, COMPRESS_BLOCK_SIZE - writerP->blockLens[ i ]);
+		memcpy(writerP->blocks[ i ] + writerP->blockLens[ i ], buff + done, n);
+		writerP->blockLens[ i ] += n;
+
+		if (writerP->blockLens[ i ] == COMPRESS_BLOCK_SIZE)
+		{
+			PrvQueueBlock(writerP);
+		}
+	}
+
+	return size;
+}
+
+
+/**
+ * @brief PrvFreeCompressWriter
+ */
+static void PrvFreeCompressWriter(CompressWriter_t *writerP)
+{
+	int i;
+
+#ifdef HAVE_ZLIB
+
+	if (writerP->compression == COMPRESSION_GZIP)
+	{
+		(void) deflateEnd(&writerP->zstream);
+	}
+
+#endif
+#ifdef HAVE_ZSTD
+	(void) ZSTD_freeCCtx(writerP->cctx);
+#endif
+
+	for (i = 0; i < COMPRESS_NUM_BLOCKS; i++)
+	{
+		free(writerP->blocks[ i ]);
+	}
+
+	free(writerP->outBuff);
+	free(writerP);
+}
+
+
+/**
+ * @brief PrvCompressClose
+ *
+ * Queue what is left, wait for the compression thread to end the
+ * stream, then close the file.
+ */
+static int PrvCompressClose(void *cookie)
+{
+	CompressWriter_t   *writerP = (CompressWriter_t *) cookie;
+	int                 err;
+
+	if (writerP->blockLens[ writerP->fill ] > 0)
+	{
+		PrvQueueBlock(writerP);
+	}
+
+	(void) pthread_mutex_lock(&writerP->mutex);
+	writerP->closing = true;
+	(void) pthread_cond_broadcast(&writerP->cond);
+	(void) pthread_mutex_unlock(&writerP->mutex);
+
+	(void) pthread_join(writerP->thread, NULL);
+
+	err = writerP->err;
+
+	if ((fclose(writerP->file) != 0) && (err == 0))
+	{
+		err = errno;
+	}
+
+	(void) pthread_mutex_destroy(&writerP->mutex);
+	(void) pthread_cond_destroy(&writerP->cond);
+	PrvFreeCompressWriter(writerP);
+
+	if (err != 0)
+	{
+		errno = err;
+		return EOF;
+	}
+
+	return 0;
+}
+
+
+/**
+ * @brief PrvInitCompressor
+ *
+ * @return true if successful else false.
+ */
+static bool PrvInitCompressor(CompressWriter_t *writerP)
+{
+	switch (writerP->compression)
+	{
+#ifdef HAVE_ZLIB
+
+		case COMPRESSION_GZIP:
+			writerP->outBuffSize = COMPRESS_BLOCK_SIZE;
+
+			/* 16 + window bits asks for a gzip header */
+			return deflateInit2(&writerP->zstream, Z_DEFAULT_COMPRESSION,
+			                    Z_DEFLATED, 16 + MAX_WBITS, 8,
+			                    Z_DEFAULT_STRATEGY) == Z_OK;
+#endif
+
+#ifdef HAVE_ZSTD
+
+		case COMPRESSION_ZSTD:
+			writerP->outBuffSize = ZSTD_CStreamOutSize();
+			writerP->cctx = ZSTD_createCCtx();
+
+			return (writerP->cctx != NULL) &&
+			       !ZSTD_isError(ZSTD_CCtx_setParameter(writerP->cctx,
+			                     ZSTD_c_checksumFlag, 1));
+#endif
+
+		default:
+			return false;
+	}
+}
+
+
+/**
+ * @brief PrvOpenCompressingFile
+ */
+static FILE *PrvOpenCompressingFile(const char *path,
+                                    Compression_t compression)
+{
+	static const cookie_io_functions_t kCompressFunctions =
+	{
+		.write  = PrvCompressWrite,
+		.close  = PrvCompressClose
+	};
+
+	CompressWriter_t   *writerP;
+	FILE               *f;
+	int                 i;
+	int                 err;
+
+	writerP = (CompressWriter_t *) calloc(1, sizeof(*writerP));
+
+	if (writerP == NULL)
+	{
+		return NULL;
+	}
+
+	writerP->compression = compression;
+
+	if (!PrvInitCompressor(writerP))
+	{
+		writerP->compression = COMPRESSION_NONE;
+		PrvFreeCompressWriter(writerP);
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	writerP->outBuff = (char *) malloc(writerP->outBuffSize);
+
+	for (i = 0; i < COMPRESS_NUM_BLOCKS; i++)
+	{
+		writerP->blocks[ i ] = (char *) malloc(COMPRESS_BLOCK_SIZE);
+
+		if (writerP->blocks[ i ] == NULL)
+		{
+			break;
+		}
+	}
+
+	if ((writerP->outBuff == NULL) || (i < COMPRESS_NUM_BLOCKS))
+	{
+		PrvFreeCompressWriter(writerP);
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	writerP->file = fopen(path, "w");
+
+	if (writerP->file == NULL)
+	{
+		err = errno;
+		PrvFreeCompressWriter(writerP);
+		errno = err;
+		return NULL;
+	}
+
+	(void) pthread_mutex_init(&writerP->mutex, NULL);
+	(void) pthread_cond_init(&writerP->cond, NULL);
+
+	err = pthread_create(&writerP->thread, NULL, PrvCompressThread, writerP);
+
+	if (err != 0)
+	{
+		(void) fclose(writerP->file);
+		(void) pthread_mutex_destroy(&writerP->mutex);
+		(void) pthread_cond_destroy(&writerP->cond);
+		PrvFreeCompressWriter(writerP);
+		errno = err;
+		return NULL;
+	}
+
+	f = fopencookie(writerP, "w", kCompressFunctions);
+
+	if (f == NULL)
+	{
+		err = errno;
+		(void) PrvCompressClose(writerP);
+		errno = err;
+	}
+
+	return f;
+}
+
+#endif /* HAVE_ZLIB || HAVE_ZSTD */
+
+
+/**
+ * @brief OpenCompressingFile
+ *
+ * Create or truncate the file for writing through the given
+ * compression, which is done on a separate thread.  The stream must
+ * be closed with fclose to complete the file.
+ * @return the stream, or NULL with errno set on error.
+ */
+FILE *OpenCompressingFile(const char *path, Compression_t compression)
+{
+	switch (compression)
+	{
+		case COMPRESSION_NONE:
+			return fopen(path, "w");
+
+#ifdef HAVE_ZLIB
+
+		case COMPRESSION_GZIP:
+			return PrvOpenCompressingFile(path, compression);
+#endif
+
+#ifdef HAVE_ZSTD
+
+		case COMPRESSION_ZSTD:
+			return PrvOpenCompressingFile(path, compression);
+#endif
+
+		default:
+			errno = ENOTSUP;
+			return NULL;
+	}
+}
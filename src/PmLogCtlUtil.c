@@ -235,3 +235,26 @@ const int *PrvLabelToInt(const IntLabel *labels, const char *s)
 
 	return NULL;
 }
+
+
+/**
+ * @brief PrvHash64
+ *
+ * Continue a 64-bit FNV-1a hash over the given bytes.  Multiple
+ * fields can be hashed by passing the previous result back in.
+ */
+uint64_t PrvHash64(uint64_t hash, const void *data, size_t len)
+{
+	const unsigned char *p;
+	size_t               i;
+
+	p = (const unsigned char *) data;
+
+	for (i = 0; i < len; i++)
+	{
+		hash ^= p[ i ];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}